@@ -0,0 +1,1415 @@
+/*******************************  COPYRIGHT  ********************************/
+/*
+ *  Copyright (c) 2019 Gregory N. Leonhardt All rights reserved.
+ *
+ ****************************************************************************/
+
+/******************************** JAVADOC ***********************************/
+/**
+ *  This file contains the benchmark for mbox2txt.  It writes a synthetic mbox
+ *  file, runs mbox2txt over it and reports the throughput and the peak
+ *  memory use.
+ *
+ *  @note
+ *      The corpus is built from a fixed seed so every run of the same
+ *      options decodes exactly the same bytes.  A percentage of the messages
+ *      are adversarial: body lines that start with 'From ', very long header
+ *      lines, body lines longer than MAX_LINE_L and 'From ' lines longer
+ *      than MAX_LINE_L.
+ *
+ *      Only the C library is used.  libtools_api.h is included for
+ *      MAX_LINE_L so the long lines really are longer than the line
+ *      buffers of the decoder start out, and index_api.h for the layout of
+ *      the '.idx' files.
+ *
+ *      With -check yes nothing is timed.  The corpus is decoded serially,
+ *      in chunks, with -pipeline, continued with -incremental after it
+ *      grew and, split into small files, with -uring.  Every output file
+ *      and index must be the same as the serial ones and every index must
+ *      match its output file.  Any difference exits with 1.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ *  Compiler directives
+ ****************************************************************************/
+
+#define _GNU_SOURCE                     //  memmem
+
+/****************************************************************************
+ * System Function API
+ ****************************************************************************/
+
+                                //*******************************************
+#include <stdint.h>             //  Alternative storage types
+#include <stdbool.h>            //  TRUE, FALSE, etc.
+#include <stdio.h>              //  Standard I/O definitions
+                                //*******************************************
+#include <string.h>             //  Functions for managing strings
+#include <stdlib.h>             //  ANSI standard library.
+#include <unistd.h>             //  UNIX standard library.
+#include <fcntl.h>              //  File control options
+#include <time.h>               //  Clocks
+#include <sys/stat.h>           //  File status
+#include <sys/wait.h>           //  Waiting for a child process
+#include <sys/resource.h>       //  Resource usage of a child process
+                                //*******************************************
+
+/****************************************************************************
+ * Application APIs
+ ****************************************************************************/
+
+                                //*******************************************
+#include <libtools_api.h>       //  My Tools Library
+                                //*******************************************
+#include <index_api.h>          //  API for all index_*             PUBLIC
+                                //*******************************************
+
+/****************************************************************************
+ * Private Definitions
+ ****************************************************************************/
+
+//----------------------------------------------------------------------------
+#define BENCH_FILE_NAME         "bench.mbox"
+#define BENCH_OUT_DIR           "bench_out"
+#define BENCH_STATS_NAME        "bench_stats.json"
+#define BENCH_BODY              "> "
+#define CHECK_THREADS           "4"
+#define CHECK_URING             "8"
+#define CHECK_PART_L            ( 1024 * 1024 )
+#define CHECK_FROM              "\nFrom sender"
+//----------------------------------------------------------------------------
+
+/****************************************************************************
+ * Private Enumerations
+ ****************************************************************************/
+
+//----------------------------------------------------------------------------
+enum    adversary_e
+{
+    AD_NONE                 =   0,
+    AD_BODY_FROM            =   1,
+    AD_LONG_HEADER          =   2,
+    AD_LONG_BODY            =   3,
+    AD_LONG_FROM            =   4,
+    AD_COUNT                =   5
+};
+//----------------------------------------------------------------------------
+
+/****************************************************************************
+ * Private Structures
+ ****************************************************************************/
+
+//----------------------------------------------------------------------------
+struct  corpus_t
+{
+    /**
+     * @param size_mb           Approximate size of the corpus in MB        */
+    size_t                          size_mb;
+    /**
+     * @param message_count     Number of messages (0 = fill size_mb)       */
+    size_t                          message_count;
+    /**
+     * @param header_count      Number of header lines in each message      */
+    int                             header_count;
+    /**
+     * @param body_line_l       Length of each body line                    */
+    int                             body_line_l;
+    /**
+     * @param body_lines        Number of body lines in each message        */
+    int                             body_lines;
+    /**
+     * @param adversary_pct     Percentage of adversarial messages          */
+    int                             adversary_pct;
+    /**
+     * @param seed              Random number seed                          */
+    unsigned int                    seed;
+    /**
+     * @param byte_count        Number of bytes written                     */
+    size_t                          byte_count;
+    /**
+     * @param line_count        Number of lines written                     */
+    size_t                          line_count;
+    /**
+     * @param messages          Number of messages written                  */
+    size_t                          messages;
+};
+//----------------------------------------------------------------------------
+
+/****************************************************************************
+ * Private Storage Allocation
+ ****************************************************************************/
+
+//----------------------------------------------------------------------------
+/**
+ * @param corpus            Description of the corpus                       */
+static
+struct  corpus_t                    corpus;
+/**
+ * @param exe_name_p        Path-name of the mbox2txt executable            */
+static
+char                            *   exe_name_p;
+/**
+ * @param work_dir_p        Directory for the corpus and the output         */
+static
+char                            *   work_dir_p;
+/**
+ * @param threads_p         Thread count handed to mbox2txt                 */
+static
+char                            *   threads_p;
+/**
+ * @param run_count         Number of timed runs                            */
+static
+int                                 run_count;
+/**
+ * @param check             TRUE to check the output instead of timing      */
+static
+int                                 check;
+//----------------------------------------------------------------------------
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************/
+/**
+ *  Locate a '-name value' parameter on the command line.
+ *
+ *  @param  argc                Number of command line parameters.
+ *  @param  argv                Indexed list of command line parameters
+ *  @param  name_p              Name of the parameter without the '-'.
+ *
+ *  @return value_p             Pointer to the value or NULL when the
+ *                              parameter is not on the command line.
+ *
+ *  @note
+ *
+ ****************************************************************************/
+
+static
+char    *
+bench_parm(
+    int                             argc,
+    char                        *   argv[],
+    char                        *   name_p
+    )
+{
+    /**
+     * @param value_p           Pointer to the value                        */
+    char                        *   value_p;
+    /**
+     * @param ndx               Index into the parameter list               */
+    int                             ndx;
+
+    /************************************************************************
+     *  Function Initialization
+     ************************************************************************/
+
+    //  The assumption is that it is not there
+    value_p = NULL;
+
+    /************************************************************************
+     *  Function
+     ************************************************************************/
+
+    //  Look at each parameter
+    for ( ndx = 1;
+          ndx < ( argc - 1 );
+          ndx += 1 )
+    {
+        //  Is this the one ?
+        if (    ( argv[ ndx ][ 0 ]                  == '-' )
+             && ( strcmp( &argv[ ndx ][ 1 ], name_p ) == 0   ) )
+        {
+            //  YES:    The value is the next parameter
+            value_p = argv[ ndx + 1 ];
+            break;
+        }
+    }
+
+    /************************************************************************
+     *  Function Exit
+     ************************************************************************/
+
+    //  DONE!
+    return( value_p );
+}
+
+/****************************************************************************/
+/**
+ *  Write one line of printable text.
+ *
+ *  @param  file_fp             Output file.
+ *  @param  prefix_p            Text at the start of the line.
+ *  @param  line_l              Length of the line without the new-line.
+ *
+ *  @return void                Nothing is returned from this function
+ *
+ *  @note
+ *      The rest of the line is lower case words so it never looks like a
+ *      'From ' line by accident.  Lower case words followed by a space do
+ *      look like an e-mail tag, so the prefix of a body line must not.
+ *
+ ****************************************************************************/
+
+static
+void
+bench_line(
+    FILE                        *   file_fp,
+    char                        *   prefix_p,
+    size_t                          line_l
+    )
+{
+    /**
+     * @param prefix_l          Length of the prefix                        */
+    size_t                          prefix_l;
+    /**
+     * @param ndx               Index into the line                         */
+    size_t                          ndx;
+
+    /************************************************************************
+     *  Function Initialization
+     ************************************************************************/
+
+    //  Start with the prefix
+    prefix_l = strlen( prefix_p );
+    fputs( prefix_p, file_fp );
+
+    /************************************************************************
+     *  Function
+     ************************************************************************/
+
+    //  Fill the rest of the line
+    for ( ndx = prefix_l;
+          ndx < line_l;
+          ndx += 1 )
+    {
+        //  A space every so often makes words
+        if ( ( rand( ) % 7 ) == 0 )
+        {
+            fputc( ' ', file_fp );
+        }
+        else
+        {
+            fputc( 'a' + ( rand( ) % 26 ), file_fp );
+        }
+    }
+    fputc( '\n', file_fp );
+
+    /************************************************************************
+     *  Function Exit
+     ************************************************************************/
+
+    //  Count it
+    corpus.byte_count += ( ( line_l > prefix_l ) ? line_l : prefix_l ) + 1;
+    corpus.line_count += 1;
+
+    //  DONE!
+}
+
+/****************************************************************************/
+/**
+ *  Write the synthetic mbox file.
+ *
+ *  @param  file_name_p         Path-name of the mbox file.
+ *
+ *  @return void                Nothing is returned from this function
+ *
+ *  @note
+ *
+ ****************************************************************************/
+
+static
+void
+bench_corpus(
+    char                        *   file_name_p
+    )
+{
+    /**
+     * @param file_fp           The mbox file                               */
+    FILE                        *   file_fp;
+    /**
+     * @param adversary         Kind of adversarial message                 */
+    enum    adversary_e             adversary;
+    /**
+     * @param line              Buffer for a formatted line                 */
+    char                            line[ 128 ];
+    /**
+     * @param ndx               Index for header and body lines             */
+    int                             ndx;
+
+    /************************************************************************
+     *  Function Initialization
+     ************************************************************************/
+
+    //  Create the mbox file
+    file_fp = fopen( file_name_p, "w" );
+
+    //  Was it created ?
+    if ( file_fp == NULL )
+    {
+        //  NO:     This is bad..
+        fprintf( stderr, "Unable to create the corpus file: '%s'\n",
+                 file_name_p );
+        exit( 1 );
+    }
+
+    //  Always build the same corpus
+    srand( corpus.seed );
+
+    /************************************************************************
+     *  Function
+     ************************************************************************/
+
+    //  Write messages until there are enough
+    while (    (    ( corpus.message_count >  0                     )
+                 && ( corpus.messages      <  corpus.message_count  ) )
+            || (    ( corpus.message_count == 0                     )
+                 && ( corpus.byte_count    <  ( corpus.size_mb << 20 ) ) ) )
+    {
+        //  Is this an adversarial message ?
+        adversary = AD_NONE;
+        if ( ( rand( ) % 100 ) < corpus.adversary_pct )
+        {
+            //  YES:    Pick one
+            adversary = 1 + ( rand( ) % ( AD_COUNT - 1 ) );
+        }
+
+        //  The 'From ' line
+        snprintf( line, sizeof( line ),
+                  "From sender%zu@example.com Mon Jan  1 00:00:00 2001",
+                  corpus.messages );
+        bench_line( file_fp, line,
+                    ( adversary == AD_LONG_FROM ) ? ( MAX_LINE_L * 2 )
+                                                  : strlen( line ) );
+
+        //  The header lines.  Tag names are letters and hyphens only; the
+        //  first three are always short tags.
+        for ( ndx = 0;
+              ndx < corpus.header_count;
+              ndx += 1 )
+        {
+            switch ( ndx )
+            {
+            case    0:  snprintf( line, sizeof( line ), "From: " );     break;
+            case    1:  snprintf( line, sizeof( line ), "Subject: " );  break;
+            case    2:  snprintf( line, sizeof( line ), "Date: " );     break;
+            default:
+                snprintf( line, sizeof( line ), "X-Header-%c%c: ",
+                          'A' + ( ( ndx / 26 ) % 26 ), 'A' + ( ndx % 26 ) );
+            }
+            bench_line( file_fp, line,
+                        (    ( adversary == AD_LONG_HEADER )
+                          && ( ndx       == 3              ) ) ? ( MAX_LINE_L * 2 )
+                                                               : 40 );
+        }
+
+        //  The blank line between the header and the body
+        bench_line( file_fp, "", 0 );
+
+        //  The body, quoted so that no line of it looks like a tag
+        for ( ndx = 0;
+              ndx < corpus.body_lines;
+              ndx += 1 )
+        {
+            //  Is this where the adversarial body line goes ?
+            if (    ( ndx       == ( corpus.body_lines / 2 ) )
+                 && ( adversary == AD_BODY_FROM              ) )
+            {
+                //  YES:    A body line that starts with 'From '
+                bench_line( file_fp, "From the body of a message ",
+                            corpus.body_line_l );
+            }
+            else if (    ( ndx       == ( corpus.body_lines / 2 ) )
+                      && ( adversary == AD_LONG_BODY              ) )
+            {
+                //  YES:    A body line longer than the decoder limit
+                bench_line( file_fp, BENCH_BODY, MAX_LINE_L * 2 );
+            }
+            else
+            {
+                //  NO:     A normal body line
+                bench_line( file_fp, BENCH_BODY, corpus.body_line_l );
+            }
+        }
+
+        //  Count it
+        corpus.messages += 1;
+    }
+
+    /************************************************************************
+     *  Function Exit
+     ************************************************************************/
+
+    //  Close the file
+    fclose( file_fp );
+
+    //  DONE!
+}
+
+/****************************************************************************/
+/**
+ *  Read the number of e-mails decoded from the statistics of a run.
+ *
+ *  @param  stats_name_p        Path-name of the -stats file.
+ *
+ *  @return messages            Number of e-mails mbox2txt reported.
+ *
+ *  @note
+ *      Only the "messages" of the "total" object is read.
+ *
+ ****************************************************************************/
+
+static
+size_t
+bench_messages(
+    char                        *   stats_name_p
+    )
+{
+    /**
+     * @param stats_fp          The statistics file                         */
+    FILE                        *   stats_fp;
+    /**
+     * @param text              Contents of the statistics file             */
+    char                            text[ 4096 ];
+    /**
+     * @param text_l            Number of bytes read                        */
+    size_t                          text_l;
+    /**
+     * @param total_p           Pointer to the totals                       */
+    char                        *   total_p;
+    /**
+     * @param messages_p        Pointer to the message count                */
+    char                        *   messages_p;
+
+    /************************************************************************
+     *  Function Initialization
+     ************************************************************************/
+
+    //  Open the statistics file
+    stats_fp = fopen( stats_name_p, "r" );
+
+    //  Was it opened ?
+    if ( stats_fp == NULL )
+    {
+        //  NO:     This is bad..
+        fprintf( stderr, "Unable to open the statistics file: '%s'\n",
+                 stats_name_p );
+        exit( 1 );
+    }
+
+    //  Read it
+    text_l = fread( text, 1, sizeof( text ) - 1, stats_fp );
+    text[ text_l ] = '\0';
+    fclose( stats_fp );
+
+    /************************************************************************
+     *  Function
+     ************************************************************************/
+
+    //  Locate the total message count
+    total_p    = strstr( text, "\"total\"" );
+    messages_p = ( total_p != NULL ) ? strstr( total_p, "\"messages\": " )
+                                     : NULL;
+
+    //  Was it found ?
+    if ( messages_p == NULL )
+    {
+        //  NO:     This is bad..
+        fprintf( stderr, "No message count in the statistics file: '%s'\n",
+                 stats_name_p );
+        exit( 1 );
+    }
+
+    /************************************************************************
+     *  Function Exit
+     ************************************************************************/
+
+    //  DONE!
+    return( strtoul( messages_p + strlen( "\"messages\": " ), NULL, 10 ) );
+}
+
+/****************************************************************************/
+/**
+ *  Run mbox2txt once.
+ *
+ *  @param  parm_p              Its command line parameters, ending with a
+ *                              NULL.
+ *  @param  max_rss_p           Where the peak RSS (KB) is returned.
+ *
+ *  @return seconds             Elapsed wall clock time.
+ *
+ *  @note
+ *
+ ****************************************************************************/
+
+static
+double
+bench_run(
+    char                        *   parm_p[ ],
+    long                        *   max_rss_p
+    )
+{
+    /**
+     * @param args_p            Command line for mbox2txt                   */
+    char                        *   args_p[ 16 ];
+    /**
+     * @param start             Time the run started                        */
+    struct  timespec                start;
+    /**
+     * @param end               Time the run ended                          */
+    struct  timespec                end;
+    /**
+     * @param usage             Resources used by the run                   */
+    struct  rusage                  usage;
+    /**
+     * @param child_pid         Process id of mbox2txt                      */
+    pid_t                           child_pid;
+    /**
+     * @param status            Exit status of mbox2txt                     */
+    int                             status;
+    /**
+     * @param null_fd           File descriptor for /dev/null               */
+    int                             null_fd;
+    /**
+     * @param ndx               Index into the command line                 */
+    int                             ndx;
+
+    /************************************************************************
+     *  Function Initialization
+     ************************************************************************/
+
+    //  Build the command line
+    args_p[ 0 ] = exe_name_p;
+
+    for ( ndx = 0;
+          (    ( parm_p[ ndx ]  != NULL                              )
+            && ( ( ndx + 2 )    <  (int)( sizeof( args_p ) / sizeof( char * ) ) ) );
+          ndx += 1 )
+    {
+        args_p[ ndx + 1 ] = parm_p[ ndx ];
+    }
+    args_p[ ndx + 1 ] = NULL;
+
+    /************************************************************************
+     *  Function
+     ************************************************************************/
+
+    //  Start the clock
+    clock_gettime( CLOCK_MONOTONIC, &start );
+
+    //  Start mbox2txt
+    child_pid = fork( );
+
+    //  Is this the child ?
+    if ( child_pid == 0 )
+    {
+        //  YES:    Throw the log messages away
+        null_fd = open( "/dev/null", O_WRONLY );
+        dup2( null_fd, STDOUT_FILENO );
+        dup2( null_fd, STDERR_FILENO );
+
+        //  Run it
+        execv( exe_name_p, args_p );
+        _exit( 127 );
+    }
+
+    //  Was the child started ?
+    if ( child_pid < 0 )
+    {
+        //  NO:     This is bad..
+        fprintf( stderr, "Unable to start '%s'\n", exe_name_p );
+        exit( 1 );
+    }
+
+    //  Wait for it to finish
+    wait4( child_pid, &status, 0, &usage );
+
+    //  Stop the clock
+    clock_gettime( CLOCK_MONOTONIC, &end );
+
+    //  Did it work ?
+    if (    ( WIFEXITED( status )   == 0 )
+         || ( WEXITSTATUS( status ) != 0 ) )
+    {
+        //  NO:     This is bad..
+        fprintf( stderr, "'%s' failed with status 0x%X\n",
+                 exe_name_p, status );
+        exit( 1 );
+    }
+
+    /************************************************************************
+     *  Function Exit
+     ************************************************************************/
+
+    //  Return the peak memory use
+    ( *max_rss_p ) = usage.ru_maxrss;
+
+    //  DONE!
+    return(   ( end.tv_sec  - start.tv_sec  )
+            + ( end.tv_nsec - start.tv_nsec ) / 1e9 );
+}
+
+/****************************************************************************/
+/**
+ *  Compare two files.
+ *
+ *  @param  name_a_p            Path-name of the first file.
+ *  @param  name_b_p            Path-name of the second file.
+ *
+ *  @return void                Nothing is returned from this function
+ *
+ *  @note
+ *      Exits with 1 when they are not the same.
+ *
+ ****************************************************************************/
+
+static
+void
+check_same(
+    char                        *   name_a_p,
+    char                        *   name_b_p
+    )
+{
+    /**
+     * @param file_a_fp         The first file                              */
+    FILE                        *   file_a_fp;
+    /**
+     * @param file_b_fp         The second file                             */
+    FILE                        *   file_b_fp;
+    /**
+     * @param buffer_a          Buffer for the first file                   */
+    static
+    char                            buffer_a[ 64 * 1024 ];
+    /**
+     * @param buffer_b          Buffer for the second file                  */
+    static
+    char                            buffer_b[ 64 * 1024 ];
+    /**
+     * @param read_a_l          Bytes read from the first file              */
+    size_t                          read_a_l;
+    /**
+     * @param read_b_l          Bytes read from the second file             */
+    size_t                          read_b_l;
+
+    /************************************************************************
+     *  Function Initialization
+     ************************************************************************/
+
+    file_a_fp = fopen( name_a_p, "r" );
+    file_b_fp = fopen( name_b_p, "r" );
+
+    //  Were they both opened ?
+    if (    ( file_a_fp == NULL )
+         || ( file_b_fp == NULL ) )
+    {
+        //  NO:     This is bad..
+        fprintf( stderr, "Unable to open '%s' or '%s'\n", name_a_p, name_b_p );
+        exit( 1 );
+    }
+
+    /************************************************************************
+     *  Function
+     ************************************************************************/
+
+    //  Compare them a block at a time
+    do
+    {
+        read_a_l = fread( buffer_a, 1, sizeof( buffer_a ), file_a_fp );
+        read_b_l = fread( buffer_b, 1, sizeof( buffer_b ), file_b_fp );
+
+        //  Are the blocks the same ?
+        if (    ( read_a_l                                  != read_b_l )
+             || ( memcmp( buffer_a, buffer_b, read_a_l )    != 0        ) )
+        {
+            //  NO:     This is bad..
+            fprintf( stderr, "'%s' and '%s' differ\n", name_a_p, name_b_p );
+            exit( 1 );
+        }
+    }   while ( read_a_l > 0 );
+
+    /************************************************************************
+     *  Function Exit
+     ************************************************************************/
+
+    fclose( file_a_fp );
+    fclose( file_b_fp );
+
+    //  DONE!
+}
+
+/****************************************************************************/
+/**
+ *  Check that the index of an output file matches it.
+ *
+ *  @param  out_name_p          Path-name of the output file.
+ *
+ *  @return record_count        Number of e-mails in the index.
+ *
+ *  @note
+ *      The e-mails must follow each other from the start to the end of the
+ *      output file and each must start with a 'From - ' line.  Exits with
+ *      1 when they do not.
+ *
+ ****************************************************************************/
+
+static
+size_t
+check_index(
+    char                        *   out_name_p
+    )
+{
+    /**
+     * @param index_name        Path-name of the index file                 */
+    char                            index_name[ 4096 ];
+    /**
+     * @param index_fp          The index file                              */
+    FILE                        *   index_fp;
+    /**
+     * @param out_fp            The output file                             */
+    FILE                        *   out_fp;
+    /**
+     * @param header            Header of the index file                    */
+    struct  index_header_t          header;
+    /**
+     * @param record            One e-mail of the index                     */
+    struct  index_record_t          record;
+    /**
+     * @param out_stat          Status of the output file                   */
+    struct  stat                    out_stat;
+    /**
+     * @param line              The start of an e-mail                      */
+    char                            line[ 8 ];
+    /**
+     * @param offset            Where the next e-mail must start            */
+    uint64_t                        offset;
+    /**
+     * @param ndx               Index into the records                      */
+    uint64_t                        ndx;
+
+    /************************************************************************
+     *  Function Initialization
+     ************************************************************************/
+
+    snprintf( index_name, sizeof( index_name ),
+              "%s%s", out_name_p, INDEX_SUFFIX );
+    index_fp = fopen( index_name, "r" );
+    out_fp   = fopen( out_name_p, "r" );
+
+    //  Can both be read ?
+    if (    ( index_fp                                            == NULL )
+         || ( out_fp                                              == NULL )
+         || ( stat( out_name_p, &out_stat )                       != 0    )
+         || ( fread( &header, sizeof( header ), 1, index_fp )     != 1    )
+         || ( memcmp( header.magic, INDEX_MAGIC, sizeof( INDEX_MAGIC ) ) != 0 )
+         || ( header.version                                      != INDEX_VERSION )
+         || ( header.record_l                                     != sizeof( record ) )
+         || ( header.output_l                      != (uint64_t)out_stat.st_size ) )
+    {
+        //  NO:     This is bad..
+        fprintf( stderr, "The index '%s' does not match its output file\n",
+                 index_name );
+        exit( 1 );
+    }
+
+    /************************************************************************
+     *  Function
+     ************************************************************************/
+
+    //  Check each e-mail
+    offset = 0;
+
+    for ( ndx = 0;
+          ndx < header.record_count;
+          ndx += 1 )
+    {
+        //  Does it start where the last one ended on a 'From - ' line ?
+        if (    ( fread( &record, sizeof( record ), 1, index_fp ) != 1      )
+             || ( record.offset                                   != offset )
+             || ( fseek( out_fp, (long)record.offset, SEEK_SET )  != 0      )
+             || ( fread( line, 1, 7, out_fp )                     != 7      )
+             || ( memcmp( line, "From - ", 7 )                    != 0      ) )
+        {
+            //  NO:     This is bad..
+            fprintf( stderr, "E-mail %llu of the index '%s' is not at a "
+                             "'From - ' line\n",
+                     (unsigned long long)ndx, index_name );
+            exit( 1 );
+        }
+        offset += record.length;
+    }
+
+    //  Does the last one end at the end of the output file ?
+    if ( offset != header.output_l )
+    {
+        //  NO:     This is bad..
+        fprintf( stderr, "The index '%s' ends at %llu, not at %llu\n",
+                 index_name, (unsigned long long)offset,
+                 (unsigned long long)header.output_l );
+        exit( 1 );
+    }
+
+    /************************************************************************
+     *  Function Exit
+     ************************************************************************/
+
+    fclose( index_fp );
+    fclose( out_fp );
+
+    //  DONE!
+    return( header.record_count );
+}
+
+/****************************************************************************/
+/**
+ *  Write the first part of a file into another file.
+ *
+ *  @param  data_p              The contents of the file.
+ *  @param  data_l              Number of bytes to write.
+ *  @param  file_name_p         Path-name of the file to write.
+ *
+ *  @return void                Nothing is returned from this function
+ *
+ *  @note
+ *
+ ****************************************************************************/
+
+static
+void
+check_write(
+    char                        *   data_p,
+    size_t                          data_l,
+    char                        *   file_name_p
+    )
+{
+    /**
+     * @param file_fp           The file being written                      */
+    FILE                        *   file_fp;
+
+    /************************************************************************
+     *  Function
+     ************************************************************************/
+
+    file_fp = fopen( file_name_p, "w" );
+
+    //  Was it written ?
+    if (    ( file_fp                                   == NULL   )
+         || ( fwrite( data_p, 1, data_l, file_fp )      != data_l )
+         || ( fclose( file_fp )                         != 0      ) )
+    {
+        //  NO:     This is bad..
+        fprintf( stderr, "Unable to write '%s'\n", file_name_p );
+        exit( 1 );
+    }
+
+    /************************************************************************
+     *  Function Exit
+     ************************************************************************/
+
+    //  DONE!
+}
+
+/****************************************************************************/
+/**
+ *  Decode one file and check it against the serial decode.
+ *
+ *  @param  parm_p              The command line parameters, ending with a
+ *                              NULL.
+ *  @param  what_p              What is being checked.
+ *  @param  out_name_p          Path-name of the output file.
+ *  @param  serial_name_p       Path-name of the serial output file, or NULL
+ *                              when this is the serial decode.
+ *  @param  stats_name_p        Path-name of the -stats file, or NULL when
+ *                              the run only decodes part of the e-mails.
+ *
+ *  @return void                Nothing is returned from this function
+ *
+ *  @note
+ *
+ ****************************************************************************/
+
+static
+void
+check_decode(
+    char                        *   parm_p[ ],
+    char                        *   what_p,
+    char                        *   out_name_p,
+    char                        *   serial_name_p,
+    char                        *   stats_name_p
+    )
+{
+    /**
+     * @param index_name        Path-name of the index file                 */
+    char                            index_name[ 4096 ];
+    /**
+     * @param serial_index      Path-name of the serial index file          */
+    char                            serial_index[ 4096 ];
+    /**
+     * @param max_rss           Peak RSS of the run                         */
+    long                            max_rss;
+    /**
+     * @param decoded           Number of e-mails mbox2txt decoded          */
+    size_t                          decoded;
+
+    /************************************************************************
+     *  Function
+     ************************************************************************/
+
+    //  Decode it
+    bench_run( parm_p, &max_rss );
+    decoded = ( stats_name_p != NULL ) ? bench_messages( stats_name_p )
+                                       : corpus.messages;
+
+    //  Was every message decoded as an e-mail and indexed ?
+    if (    ( decoded                       != corpus.messages )
+         || ( check_index( out_name_p )     != corpus.messages ) )
+    {
+        //  NO:     This is bad..
+        fprintf( stderr, "%s: %zu messages were written but %zu e-mails "
+                         "were decoded\n", what_p, corpus.messages, decoded );
+        exit( 1 );
+    }
+
+    //  Is it the same as the serial decode ?
+    if ( serial_name_p != NULL )
+    {
+        snprintf( index_name, sizeof( index_name ),
+                  "%s%s", out_name_p, INDEX_SUFFIX );
+        snprintf( serial_index, sizeof( serial_index ),
+                  "%s%s", serial_name_p, INDEX_SUFFIX );
+        check_same( serial_name_p, out_name_p );
+        check_same( serial_index, index_name );
+    }
+
+    /************************************************************************
+     *  Function Exit
+     ************************************************************************/
+
+    printf( "Check:      %-12s ok\n", what_p );
+
+    //  DONE!
+}
+
+/****************************************************************************/
+/**
+ *  Check that every way of decoding the corpus writes the same output.
+ *
+ *  @param  file_name_p         Path-name of the corpus.
+ *
+ *  @return void                Nothing is returned from this function
+ *
+ *  @note
+ *      Exits with 1 at the first difference.
+ *
+ ****************************************************************************/
+
+static
+void
+bench_check(
+    char                        *   file_name_p
+    )
+{
+    /**
+     * @param data_p            The contents of the corpus                  */
+    char                        *   data_p;
+    /**
+     * @param data_l            Size of the corpus                          */
+    size_t                          data_l;
+    /**
+     * @param file_fp           The corpus file                             */
+    FILE                        *   file_fp;
+    /**
+     * @param in_dir            Input directory                             */
+    char                            in_dir[ 4096 ];
+    /**
+     * @param out_dir           Output directory                            */
+    char                            out_dir[ 4096 ];
+    /**
+     * @param ring_dir          Output directory of the ring                */
+    char                            ring_dir[ 4096 ];
+    /**
+     * @param in_name           Path-name of an input file                  */
+    char                            in_name[ 4096 ];
+    /**
+     * @param out_name          Path-name of an output file                 */
+    char                            out_name[ 4096 ];
+    /**
+     * @param serial_name       Path-name of the serial output file         */
+    char                            serial_name[ 4096 ];
+    /**
+     * @param stats_name        Path-name of the -stats file                */
+    char                            stats_name[ 4096 ];
+    /**
+     * @param manifest_name     Path-name of the -incremental manifest      */
+    char                            manifest_name[ 4096 ];
+    /**
+     * @param serial_parm       Serial decode of the corpus                 */
+    char                        *   serial_parm[ ] = { "-if", file_name_p,
+                                                       "-od", out_dir,
+                                                       "-index", "yes",
+                                                       "-stats", stats_name,
+                                                       NULL };
+    /**
+     * @param chunked_parm      Decode of the corpus in chunks              */
+    char                        *   chunked_parm[ ] = { "-if", file_name_p,
+                                                        "-od", out_dir,
+                                                        "-index", "yes",
+                                                        "-stats", stats_name,
+                                                        "-threads", CHECK_THREADS,
+                                                        NULL };
+    /**
+     * @param pipeline_parm     Decode of the corpus with -pipeline         */
+    char                        *   pipeline_parm[ ] = { "-if", file_name_p,
+                                                         "-od", out_dir,
+                                                         "-index", "yes",
+                                                         "-stats", stats_name,
+                                                         "-pipeline", "yes",
+                                                         NULL };
+    /**
+     * @param resume_parm       Decode of a corpus that grows               */
+    char                        *   resume_parm[ ] = { "-if", in_name,
+                                                       "-od", out_dir,
+                                                       "-index", "yes",
+                                                       "-stats", stats_name,
+                                                       "-incremental", manifest_name,
+                                                       NULL };
+    /**
+     * @param parts_parm        Serial decode of the parts                  */
+    char                        *   parts_parm[ ] = { "-id", in_dir,
+                                                      "-od", out_dir,
+                                                      "-index", "yes",
+                                                      NULL };
+    /**
+     * @param ring_parm         Decode of the parts on the ring             */
+    char                        *   ring_parm[ ] = { "-id", in_dir,
+                                                     "-od", ring_dir,
+                                                     "-index", "yes",
+                                                     "-uring", CHECK_URING,
+                                                     NULL };
+    /**
+     * @param start             Start of a part of the corpus               */
+    size_t                          start;
+    /**
+     * @param end               End of a part of the corpus                 */
+    size_t                          end;
+    /**
+     * @param from_p            Start of the next e-mail                    */
+    char                        *   from_p;
+    /**
+     * @param part_count        Number of parts                             */
+    int                             part_count;
+    /**
+     * @param max_rss           Peak RSS of a run                           */
+    long                            max_rss;
+    /**
+     * @param ndx               Index into the parts                        */
+    int                             ndx;
+
+    /************************************************************************
+     *  Function Initialization
+     ************************************************************************/
+
+    //  Read the corpus
+    file_fp = fopen( file_name_p, "r" );
+    data_l  = corpus.byte_count;
+    data_p  = malloc( data_l );
+
+    if (    ( file_fp                                   == NULL   )
+         || ( data_p                                    == NULL   )
+         || ( fread( data_p, 1, data_l, file_fp )       != data_l ) )
+    {
+        //  NO:     This is bad..
+        fprintf( stderr, "Unable to read the corpus file: '%s'\n", file_name_p );
+        exit( 1 );
+    }
+    fclose( file_fp );
+
+    snprintf( stats_name, sizeof( stats_name ),
+              "%s/%s", work_dir_p, BENCH_STATS_NAME );
+    snprintf( manifest_name, sizeof( manifest_name ),
+              "%s/check.manifest", work_dir_p );
+    snprintf( serial_name, sizeof( serial_name ),
+              "%s/check_serial/%s", work_dir_p, BENCH_FILE_NAME );
+
+    /************************************************************************
+     *  Function
+     ************************************************************************/
+
+    //  Serially
+    snprintf( out_dir, sizeof( out_dir ), "%s/check_serial", work_dir_p );
+    check_decode( serial_parm, "serial", serial_name, NULL, stats_name );
+
+    //  In chunks
+    snprintf( out_dir, sizeof( out_dir ), "%s/check_chunked", work_dir_p );
+    snprintf( out_name, sizeof( out_name ), "%s/%s", out_dir, BENCH_FILE_NAME );
+    check_decode( chunked_parm, "chunked", out_name, serial_name, stats_name );
+
+    //  With the reads and writes on threads of their own
+    snprintf( out_dir, sizeof( out_dir ), "%s/check_pipeline", work_dir_p );
+    snprintf( out_name, sizeof( out_name ), "%s/%s", out_dir, BENCH_FILE_NAME );
+    check_decode( pipeline_parm, "pipeline", out_name, serial_name, stats_name );
+
+    //  Continued after the file grew.  The first run stops at the end of the
+    //  line in the middle of the corpus.
+    snprintf( in_dir, sizeof( in_dir ), "%s/check_resume", work_dir_p );
+    snprintf( in_name, sizeof( in_name ), "%s/%s", in_dir, BENCH_FILE_NAME );
+    snprintf( out_dir, sizeof( out_dir ), "%s/out", in_dir );
+    snprintf( out_name, sizeof( out_name ), "%s/%s", out_dir, BENCH_FILE_NAME );
+    mkdir( in_dir, 0755 );
+    unlink( manifest_name );
+
+    for ( end = data_l / 2;
+          ( end < data_l ) && ( data_p[ end - 1 ] != '\n' );
+          end += 1 )
+    {
+    }
+
+    check_write( data_p, end, in_name );
+    bench_run( resume_parm, &max_rss );
+    check_write( data_p, data_l, in_name );
+    check_decode( resume_parm, "resume", out_name, serial_name, NULL );
+
+    //  Split into files small enough for the ring.  Each part starts on a
+    //  'From ' line of the corpus.
+    snprintf( in_dir, sizeof( in_dir ), "%s/check_parts", work_dir_p );
+    snprintf( out_dir, sizeof( out_dir ), "%s/out", in_dir );
+    snprintf( ring_dir, sizeof( ring_dir ), "%s/check_uring", work_dir_p );
+    mkdir( in_dir, 0755 );
+    part_count = 0;
+
+    for ( start = 0;
+          start < data_l;
+          start = end )
+    {
+        from_p = ( ( start + CHECK_PART_L ) < data_l )
+                    ? memmem( data_p + start + CHECK_PART_L,
+                              data_l - start - CHECK_PART_L,
+                              CHECK_FROM, strlen( CHECK_FROM ) )
+                    : NULL;
+        end    = ( from_p != NULL ) ? (size_t)( from_p - data_p ) + 1 : data_l;
+
+        snprintf( in_name, sizeof( in_name ),
+                  "%s/part%04d.mbox", in_dir, part_count );
+        check_write( data_p + start, end - start, in_name );
+        part_count += 1;
+    }
+
+    //  Serially and on the ring
+    bench_run( parts_parm, &max_rss );
+    bench_run( ring_parm,  &max_rss );
+
+    for ( ndx = 0;
+          ndx < part_count;
+          ndx += 1 )
+    {
+        snprintf( in_name, sizeof( in_name ),
+                  "%s/part%04d.mbox", out_dir, ndx );
+        snprintf( out_name, sizeof( out_name ),
+                  "%s/part%04d.mbox", ring_dir, ndx );
+        check_index( in_name );
+        check_same( in_name, out_name );
+        strcat( in_name,  INDEX_SUFFIX );
+        strcat( out_name, INDEX_SUFFIX );
+        check_same( in_name, out_name );
+    }
+    printf( "Check:      %-12s ok (%d files)\n", "uring", part_count );
+
+    /************************************************************************
+     *  Function Exit
+     ************************************************************************/
+
+    free( data_p );
+
+    //  DONE!
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************/
+/**
+ *  This is the main entry point for the benchmark.
+ *
+ *  @param  argc                Number of command line parameters.
+ *  @param  argv                Indexed list of command line parameters
+ *
+ *  @return                     Zero for success. Any other value is an error.
+ *
+ *  @note
+ *
+ ****************************************************************************/
+
+int
+main(
+    int                             argc,
+    char                        *   argv[ ]
+    )
+{
+    /**
+     * @param parm_p            Pointer to a command line parameter         */
+    char                        *   parm_p;
+    /**
+     * @param file_name         Path-name of the corpus                     */
+    char                            file_name[ 4096 ];
+    /**
+     * @param out_dir           Path-name of the output directory           */
+    char                            out_dir[ 4096 ];
+    /**
+     * @param stats_name        Path-name of the -stats file                */
+    char                            stats_name[ 4096 ];
+    /**
+     * @param run_parm          Command line of a timed run                 */
+    char                        *   run_parm[ ] = { "-if", file_name,
+                                                    "-od", out_dir,
+                                                    "-stats", stats_name,
+                                                    NULL, NULL, NULL };
+    /**
+     * @param decoded           Number of e-mails mbox2txt decoded          */
+    size_t                          decoded;
+    /**
+     * @param seconds           Time for one run                            */
+    double                          seconds;
+    /**
+     * @param best              Time for the fastest run                    */
+    double                          best;
+    /**
+     * @param max_rss           Peak RSS of one run                         */
+    long                            max_rss;
+    /**
+     * @param peak_rss          Largest peak RSS of all runs                */
+    long                            peak_rss;
+    /**
+     * @param ndx               Run number                                  */
+    int                             ndx;
+
+    /************************************************************************
+     *  Application Initialization
+     ************************************************************************/
+
+    //  Defaults
+    memset( &corpus, 0, sizeof( corpus ) );
+    corpus.size_mb       = 256;
+    corpus.header_count  = 12;
+    corpus.body_line_l   = 72;
+    corpus.body_lines    = 40;
+    corpus.adversary_pct = 5;
+    corpus.seed          = 1;
+    exe_name_p           = "dist/Debug/GNU-Linux/mbox2txt";
+    work_dir_p           = "build/bench";
+    threads_p            = NULL;
+    run_count            = 3;
+    check                = false;
+
+    //  Scan the command line
+    if ( ( parm_p = bench_parm( argc, argv, "size"     ) ) != NULL )
+        corpus.size_mb       = strtoul( parm_p, NULL, 10 );
+    if ( ( parm_p = bench_parm( argc, argv, "messages" ) ) != NULL )
+        corpus.message_count = strtoul( parm_p, NULL, 10 );
+    if ( ( parm_p = bench_parm( argc, argv, "headers"  ) ) != NULL )
+        corpus.header_count  = atoi( parm_p );
+    if ( ( parm_p = bench_parm( argc, argv, "body"     ) ) != NULL )
+        corpus.body_line_l   = atoi( parm_p );
+    if ( ( parm_p = bench_parm( argc, argv, "lines"    ) ) != NULL )
+        corpus.body_lines    = atoi( parm_p );
+    if ( ( parm_p = bench_parm( argc, argv, "adverse"  ) ) != NULL )
+        corpus.adversary_pct = atoi( parm_p );
+    if ( ( parm_p = bench_parm( argc, argv, "seed"     ) ) != NULL )
+        corpus.seed          = strtoul( parm_p, NULL, 10 );
+    if ( ( parm_p = bench_parm( argc, argv, "runs"     ) ) != NULL )
+        run_count            = atoi( parm_p );
+    if ( ( parm_p = bench_parm( argc, argv, "exe"      ) ) != NULL )
+        exe_name_p           = parm_p;
+    if ( ( parm_p = bench_parm( argc, argv, "dir"      ) ) != NULL )
+        work_dir_p           = parm_p;
+    if ( ( parm_p = bench_parm( argc, argv, "check"    ) ) != NULL )
+        check                = ( strcmp( parm_p, "yes" ) == 0 );
+    threads_p = bench_parm( argc, argv, "threads" );
+
+    //  Is a thread count handed to mbox2txt ?
+    if ( threads_p != NULL )
+    {
+        //  YES:    Add it to the timed run
+        run_parm[ 6 ] = "-threads";
+        run_parm[ 7 ] = threads_p;
+    }
+
+    //  The tag lookahead needs at least four header lines
+    if ( corpus.header_count < 4 ) corpus.header_count = 4;
+    if ( run_count           < 1 ) run_count           = 1;
+
+    //  Build the file names
+    snprintf( file_name, sizeof( file_name ),
+              "%s/%s", work_dir_p, BENCH_FILE_NAME );
+    snprintf( out_dir, sizeof( out_dir ),
+              "%s/%s", work_dir_p, BENCH_OUT_DIR );
+    snprintf( stats_name, sizeof( stats_name ),
+              "%s/%s", work_dir_p, BENCH_STATS_NAME );
+    mkdir( work_dir_p, 0755 );
+    mkdir( out_dir, 0755 );
+
+    /************************************************************************
+     *  Main line code
+     ************************************************************************/
+
+    //  Build the corpus
+    bench_corpus( file_name );
+
+    printf( "Corpus:     %s\n", file_name );
+    printf( "            %.1f MB, %zu messages, %zu lines, "
+            "%d%% adversarial\n",
+            corpus.byte_count / 1048576.0, corpus.messages,
+            corpus.line_count, corpus.adversary_pct );
+
+    //  Is the output being checked ?
+    if ( check == true )
+    {
+        //  YES:    Nothing is timed
+        bench_check( file_name );
+        return( 0 );
+    }
+
+    //  Time each run and keep the best
+    best     = 0;
+    peak_rss = 0;
+    decoded  = 0;
+
+    for ( ndx = 0;
+          ndx < run_count;
+          ndx += 1 )
+    {
+        seconds = bench_run( run_parm, &max_rss );
+        printf( "Run %-3d     %.3f s\n", ndx + 1, seconds );
+
+        //  Was every message decoded as an e-mail ?
+        decoded = bench_messages( stats_name );
+
+        if ( decoded != corpus.messages )
+        {
+            //  NO:     The corpus does not test the decode loop
+            fprintf( stderr, "%zu messages were written but %zu e-mails "
+                             "were decoded\n", corpus.messages, decoded );
+            exit( 1 );
+        }
+
+        if ( ( ndx == 0 ) || ( seconds < best ) ) best = seconds;
+        if ( max_rss > peak_rss ) peak_rss = max_rss;
+    }
+
+    //  Report the results
+    printf( "Best:       %.3f s\n", best );
+    printf( "            %.1f MB/s\n",
+            ( corpus.byte_count / 1048576.0 ) / best );
+    printf( "            %.0f messages/s\n", decoded / best );
+    printf( "            %.0f lines/s\n", corpus.line_count / best );
+    printf( "Peak RSS:   %ld KB\n", peak_rss );
+
+    /************************************************************************
+     *  Application Exit
+     ************************************************************************/
+
+    //  DONE!
+    return( 0 );
+}
+
+/****************************************************************************/